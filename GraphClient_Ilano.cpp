@@ -0,0 +1,114 @@
+/*
+Author: Gabriel Ilano
+Date: 4/19/24
+Description: Small client for the graph server, sends request lines from stdin and prints each response
+*/
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <poll.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+using namespace std;
+
+int main(int argc, char* argv[]) {
+    if (argc != 2) { //prints usage if socket path is missing
+        cerr << "Usage: " << argv[0] << " <socket>\n"
+             << "Requests are read from stdin, one per line:\n"
+             << "  BFS <start> <end>\n"
+             << "  DIJKSTRA <start> <end>\n"
+             << "  ALL <vertex>\n"
+             << "  PING\n";
+        return 1;
+    }
+
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, argv[1], sizeof(address.sun_path) - 1);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd == -1 || connect(fd, (sockaddr*)&address, sizeof(address)) == -1) { //prints error message if server is not running
+        cerr << "Could not connect to " << argv[1] << endl;
+        return 1;
+    }
+
+    string requests;
+    string line;
+    while (getline(cin, line)) { //every request is read up front so they can be pipelined
+        requests += line + "\n";
+    }
+
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK); //answers are read while requests are still being sent
+
+    size_t sent = 0;
+    bool done = false; //server closed connection after last answer
+    string received;
+    char buffer[4096];
+
+    if (requests.empty()) { //nothing to send
+        shutdown(fd, SHUT_WR);
+    }
+
+    while (!done) { //server stops reading once too many answers wait, so both directions must be serviced together
+        pollfd watch = {fd, POLLIN, 0};
+        if (sent < requests.size()) {
+            watch.events |= POLLOUT;
+        }
+        if (poll(&watch, 1, -1) == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            cerr << "Poll failed" << endl;
+            close(fd);
+            return 1;
+        }
+
+        if (watch.revents & (POLLIN | POLLHUP | POLLERR)) {
+            ssize_t count = read(fd, buffer, sizeof(buffer));
+            while (count > 0) { //collect every available byte
+                received.append(buffer, count);
+                count = read(fd, buffer, sizeof(buffer));
+            }
+            if (count == 0) {
+                done = true;
+            } else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                cerr << "Could not read answers" << endl;
+                close(fd);
+                return 1;
+            }
+
+            size_t newline = received.find('\n');
+            while (newline != string::npos) { //prints each complete response, byte length on one line then the text
+                size_t length = stoul(received.substr(0, newline));
+                if (received.size() < newline + 1 + length) { //rest of response has not arrived yet
+                    break;
+                }
+                cout << received.substr(newline + 1, length);
+                received.erase(0, newline + 1 + length);
+                newline = received.find('\n');
+            }
+        }
+
+        if (!done && sent < requests.size() && (watch.revents & POLLOUT)) {
+            ssize_t count = send(fd, requests.data() + sent, requests.size() - sent, MSG_NOSIGNAL);
+            if (count > 0) {
+                sent += count;
+                if (sent == requests.size()) { //server closes connection after last answer
+                    shutdown(fd, SHUT_WR);
+                }
+            } else if (count == -1 && errno != EAGAIN && errno != EWOULDBLOCK) {
+                cerr << "Could not send requests" << endl;
+                close(fd);
+                return 1;
+            }
+        }
+    }
+    close(fd);
+
+    return 0;
+}
@@ -0,0 +1,364 @@
+/*
+Author: Gabriel Ilano
+Date: 4/19/24
+Description: Definitions for the Graph Server Class with a poll based event loop and worker pool
+*/
+
+#include "GraphServer_Ilano.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+using namespace std;
+
+static void setNonBlocking(int fd) { //event loop must never block on a single client
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+}
+
+GraphServer::GraphServer(string socketPath, int workerCount, function<string(const string&)> handler) { //constructor
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    if (socketPath.size() >= sizeof(address.sun_path)) { //throws exception if path does not fit in address
+        throw invalid_argument("Socket path is too long");
+    }
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, socketPath.c_str());
+
+    listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd == -1) {
+        throw runtime_error("Could not create socket");
+    }
+
+    struct stat existing;
+    if (lstat(socketPath.c_str(), &existing) == 0) { //only a stale socket may be replaced
+        if (!S_ISSOCK(existing.st_mode)) {
+            close(listenFd);
+            throw runtime_error(socketPath + " already exists and is not a socket");
+        }
+
+        int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+        bool live = probe != -1 && connect(probe, (sockaddr*)&address, sizeof(address)) == 0;
+        if (probe != -1) {
+            close(probe);
+        }
+        if (live) { //another server is still answering on this path
+            close(listenFd);
+            throw runtime_error(socketPath + " is in use by a running server");
+        }
+        unlink(socketPath.c_str()); //removes socket left behind by a server that exited
+    }
+
+    if (bind(listenFd, (sockaddr*)&address, sizeof(address)) == -1 || listen(listenFd, SOMAXCONN) == -1) {
+        close(listenFd);
+        throw runtime_error("Could not listen on " + socketPath);
+    }
+
+    if (pipe(wakeFds) == -1) {
+        close(listenFd);
+        throw runtime_error("Could not create wake pipe");
+    }
+    spareFd = open("/dev/null", O_RDONLY); //held back so a client can still be accepted and turned away when out of descriptors
+
+    setNonBlocking(listenFd);
+    setNonBlocking(wakeFds[0]);
+    setNonBlocking(wakeFds[1]);
+
+    this->socketPath = socketPath;
+    this->handler = handler;
+    nextConnection = 0;
+    acceptPaused = false;
+    running = true;
+
+    for (int i = 0; i < max(workerCount, 1); i++) { //start worker pool
+        workers.push_back(thread(&GraphServer::work, this));
+    }
+}
+
+GraphServer::~GraphServer() { //destructor
+    {
+        lock_guard<mutex> lock(requestLock);
+        running = false;
+    }
+    requestReady.notify_all(); //wakes idle workers so they can exit
+
+    for (int i = 0; i < static_cast<int>(workers.size()); i++) {
+        workers[i].join();
+    }
+
+    for (auto& entry : connections) { //closes remaining clients
+        close(entry.second.fd);
+    }
+    close(listenFd);
+    close(wakeFds[0]);
+    close(wakeFds[1]);
+    if (spareFd != -1) {
+        close(spareFd);
+    }
+    unlink(socketPath.c_str());
+}
+
+void GraphServer::stop() { //only touches an atomic and a pipe so it is safe within a signal handler
+    running = false;
+    char wake = 0;
+    if (write(wakeFds[1], &wake, 1) == -1) { //pipe already full means the loop is about to wake anyway
+        return;
+    }
+}
+
+void GraphServer::work() { //answers requests until server stops
+    while (true) {
+        request next;
+        {
+            unique_lock<mutex> lock(requestLock);
+            requestReady.wait(lock, [this] { return !requests.empty() || !running; });
+            if (!running) {
+                return;
+            }
+            next = requests.front();
+            requests.pop_front();
+        }
+
+        string text;
+        try {
+            text = handler(next.line);
+        } catch (exception& error) { //a bad request should not take down the server
+            text = string("ERR ") + error.what() + "\n";
+        }
+
+        {
+            lock_guard<mutex> lock(responseLock);
+            responses.push_back({next.connection, next.sequence, text});
+        }
+
+        char wake = 0;
+        if (write(wakeFds[1], &wake, 1) == -1) { //pipe already full means the loop is about to wake anyway
+            continue;
+        }
+    }
+}
+
+void GraphServer::run() { //polls listener, wake pipe, and every client until stop is called
+    while (running) {
+        vector<pollfd> fds;
+        vector<int> ids; //connection id for each client entry in fds
+        fds.push_back({listenFd, static_cast<short>(acceptPaused ? 0 : POLLIN), 0});
+        fds.push_back({wakeFds[0], POLLIN, 0});
+
+        for (auto& entry : connections) {
+            short events = 0;
+            if (!entry.second.closing && entry.second.input.size() < MAX_INPUT_BYTES && hasRoom(entry.second)) { //stop reading a client that is not reading its answers
+                events |= POLLIN;
+            }
+            if (!entry.second.output.empty()) { //only wait for space when there is something to write
+                events |= POLLOUT;
+            }
+            fds.push_back({entry.second.fd, events, 0});
+            ids.push_back(entry.first);
+        }
+
+        int timeout = acceptPaused ? 100 : -1; //paused listener is retried after 100ms
+        acceptPaused = false;
+        if (poll(fds.data(), fds.size(), timeout) == -1) {
+            if (errno == EINTR) { //interrupted by signal, recheck running
+                continue;
+            }
+            throw runtime_error("Poll failed");
+        }
+
+        if (fds[1].revents != 0) { //workers finished responses
+            char drain[256];
+            while (read(wakeFds[0], drain, sizeof(drain)) > 0) {}
+            collectResponses();
+        }
+
+        if (fds[0].revents != 0) {
+            acceptClients();
+        }
+
+        for (int i = 0; i < static_cast<int>(ids.size()); i++) {
+            auto found = connections.find(ids[i]);
+            if (found == connections.end()) { //closed while collecting responses
+                continue;
+            }
+            connection& client = found->second;
+            short events = fds[i + 2].revents;
+
+            if (events & (POLLHUP | POLLERR)) { //client closed both directions, so answers can no longer be sent
+                dropClient(client);
+            } else {
+                if (events & POLLIN) {
+                    readClient(client);
+                }
+                if (client.fd != -1 && (events & POLLOUT)) {
+                    writeClient(client);
+                }
+            }
+
+            if (client.fd != -1) { //writing or finished answers may have made room for buffered lines
+                queueRequests(client);
+            }
+
+            if (client.fd == -1 || (client.closing && client.input.empty() && client.nextResponse == client.nextRequest && client.output.empty())) { //every answer sent or client is gone
+                if (client.fd != -1) {
+                    close(client.fd);
+                }
+                connections.erase(found);
+            }
+        }
+    }
+}
+
+void GraphServer::acceptClients() { //accepts every waiting client
+    while (true) {
+        int fd = accept(listenFd, nullptr, nullptr);
+        if (fd == -1) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) { //no more waiting clients
+                return;
+            }
+            if (errno == EINTR || errno == ECONNABORTED) { //client gave up before it was accepted
+                continue;
+            }
+            if ((errno == EMFILE || errno == ENFILE) && spareFd != -1) { //out of descriptors, turn the client away so poll does not spin
+                close(spareFd);
+                int refused = accept(listenFd, nullptr, nullptr);
+                if (refused != -1) {
+                    close(refused);
+                }
+                spareFd = open("/dev/null", O_RDONLY);
+                if (refused == -1) { //accept reports EMFILE even when nobody is waiting
+                    return;
+                }
+                cerr << "Out of file descriptors, refused a client" << endl;
+                continue;
+            }
+            cerr << "Could not accept client: " << strerror(errno) << endl;
+            acceptPaused = true; //listener is left out of the next poll so a lasting error does not spin
+            return;
+        }
+        setNonBlocking(fd);
+
+        connection client;
+        client.id = nextConnection;
+        client.fd = fd;
+        client.nextRequest = 0;
+        client.nextResponse = 0;
+        client.closing = false;
+        connections[nextConnection] = client;
+        nextConnection++;
+    }
+}
+
+bool GraphServer::hasRoom(const connection& client) { //limits how much work and output one client can pile up
+    return client.nextRequest - client.nextResponse < MAX_IN_FLIGHT && client.output.size() < MAX_OUTPUT_BYTES;
+}
+
+void GraphServer::readClient(connection& client) { //reads available bytes and queues each complete line
+    char buffer[4096];
+
+    while (client.input.size() < MAX_INPUT_BYTES) { //rest stays in the socket until buffered lines are handled
+        ssize_t count = read(client.fd, buffer, sizeof(buffer));
+        if (count > 0) {
+            client.input.append(buffer, count);
+        } else if (count == 0) { //client is done sending, answers are still written
+            client.closing = true;
+            break;
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            break;
+        } else { //connection is broken, drop client
+            dropClient(client);
+            return;
+        }
+    }
+
+    if (client.closing && !client.input.empty() && client.input.back() != '\n') { //last request may end without a newline
+        client.input += "\n";
+    }
+
+    if (client.input.size() >= MAX_INPUT_BYTES && client.input.find('\n') == string::npos) { //request longer than the limit
+        dropClient(client);
+        return;
+    }
+
+    queueRequests(client);
+}
+
+void GraphServer::queueRequests(connection& client) { //splits buffered input into requests for the workers
+    vector<request> lines;
+    size_t newline = client.input.find('\n');
+    while (newline != string::npos && hasRoom(client)) { //every line is its own request, so clients can pipeline
+        string line = client.input.substr(0, newline);
+        client.input.erase(0, newline + 1);
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (!line.empty()) {
+            lines.push_back({client.id, client.nextRequest, line});
+            client.nextRequest++;
+        }
+        newline = client.input.find('\n');
+    }
+
+    if (!lines.empty()) {
+        {
+            lock_guard<mutex> lock(requestLock);
+            for (int i = 0; i < static_cast<int>(lines.size()); i++) {
+                requests.push_back(lines[i]);
+            }
+        }
+        requestReady.notify_all();
+    }
+}
+
+void GraphServer::writeClient(connection& client) { //writes as much queued output as the socket accepts
+    while (!client.output.empty()) {
+        ssize_t count = send(client.fd, client.output.data(), client.output.size(), MSG_NOSIGNAL);
+        if (count > 0) {
+            client.output.erase(0, count);
+        } else if (count == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) { //wait for POLLOUT
+            return;
+        } else { //connection is broken, drop client
+            dropClient(client);
+            return;
+        }
+    }
+}
+
+void GraphServer::dropClient(connection& client) { //requests already running still finish, their answers are discarded
+    close(client.fd);
+    client.fd = -1;
+
+    lock_guard<mutex> lock(requestLock);
+    int id = client.id;
+    requests.erase(remove_if(requests.begin(), requests.end(), [id](const request& queued) { return queued.connection == id; }), requests.end());
+}
+
+void GraphServer::collectResponses() { //frames finished responses in request order
+    vector<response> done;
+    {
+        lock_guard<mutex> lock(responseLock);
+        done.swap(responses);
+    }
+
+    for (int i = 0; i < static_cast<int>(done.size()); i++) {
+        auto found = connections.find(done[i].connection);
+        if (found == connections.end()) { //client already disconnected
+            continue;
+        }
+        connection& client = found->second;
+        client.finished[done[i].sequence] = done[i].text;
+
+        auto next = client.finished.find(client.nextResponse);
+        while (next != client.finished.end()) { //each response is its byte length on one line then the text
+            client.output += to_string(next->second.size()) + "\n" + next->second;
+            client.finished.erase(next);
+            client.nextResponse++;
+            next = client.finished.find(client.nextResponse);
+        }
+    }
+}
@@ -0,0 +1,81 @@
+/*
+Author: Gabriel Ilano
+Date: 4/19/24
+Description: Declarations for the Graph Server Class, answers line requests over a unix domain socket with a pool of workers
+*/
+
+#ifndef GRAPHSERVER_ILANO_H
+#define GRAPHSERVER_ILANO_H
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdexcept>
+using namespace std;
+
+const int MAX_IN_FLIGHT = 64; //requests queued or running per connection before reading pauses
+const size_t MAX_INPUT_BYTES = 64 * 1024; //unparsed bytes held per connection, also the longest allowed request
+const size_t MAX_OUTPUT_BYTES = 1024 * 1024; //unsent response bytes per connection before reading pauses
+
+struct request {
+    int connection; //id of connection that sent the request
+    long long sequence; //order of request within its connection
+    string line;
+};
+
+struct response {
+    int connection;
+    long long sequence;
+    string text;
+};
+
+struct connection {
+    int id;
+    int fd;
+    string input; //bytes read but not yet split into lines
+    string output; //framed responses waiting to be written
+    long long nextRequest; //sequence given to next request read
+    long long nextResponse; //sequence of next response to write, keeps pipelined answers in order
+    map<long long, string> finished; //responses that finished ahead of earlier ones
+    bool closing; //client stopped sending, close once every answer is written
+};
+
+class GraphServer {
+private: //variable declarations
+    string socketPath;
+    int listenFd;
+    int wakeFds[2]; //workers write to wakeFds[1] so poll sees finished responses
+    int spareFd; //closed to make room for accepting and refusing a client when descriptors run out
+    int nextConnection;
+    bool acceptPaused; //set after an accept error so the listener sits out one poll
+    atomic<bool> running; //atomic so stop can be called from a signal handler
+    function<string(const string&)> handler; //turns one request line into its response text
+    map<int, connection> connections;
+    vector<thread> workers;
+    deque<request> requests; //shared with workers
+    mutex requestLock;
+    condition_variable requestReady;
+    vector<response> responses; //filled by workers, drained by event loop
+    mutex responseLock;
+
+    void work(); //worker loop
+    void acceptClients();
+    bool hasRoom(const connection& client); //true while client is under its in flight and output limits
+    void readClient(connection& client);
+    void queueRequests(connection& client); //hands complete lines to workers while client has room
+    void dropClient(connection& client); //closes client and discards its queued requests
+    void writeClient(connection& client);
+    void collectResponses();
+
+public: //method declarations
+    GraphServer(string socketPath, int workerCount, function<string(const string&)> handler);
+    ~GraphServer();
+    void run(); //event loop, returns once stop is called
+    void stop();
+};
+#endif
@@ -5,6 +5,8 @@ Description: Contains main function and logic for Matrix Graph implementation wi
 */
 
 #include "MatrixGraph_Ilano.h"
+#include "GraphServer_Ilano.h"
+#include <csignal>
 #include <iostream>
 #include <fstream>
 #include <sstream>
@@ -26,67 +28,64 @@ void printMenu() { //prints menu of choices and operations
          << "0) Quit\n";
 }
 
-string findPath(MatrixGraph& graph) { //returns string based on path between given vertices
-    int start;
-    int end;
+string findPath(MatrixGraph& graph, int start, int end) { //returns string based on path between given vertices
     stringstream result;
+    snapshot pinned = graph.pinSnapshot(); //search and weights all come from the same version
 
-    cin >> start >> end; //get user input of vertices
-
-    if (!graph.pathExists(start, end)) { //prints error message if no path is found between given vertices
+    if (!graph.pathExists(start, end, pinned)) { //prints error message if no path is found between given vertices
         result << "No BFS path from " << start << " to " << end << "." << endl;
     } else {
         result << "BFS path from " << start << " to " << end << " is:" << endl;
-        vector<int> path = graph.getBFSPath(start, end); //generate vector of path between vertices
+        vector<int> path = graph.getBFSPath(start, end, pinned); //generate vector of path between vertices
 
         result << "[" << setw(2) << path[0] << ":" << setw(6) << fixed << setprecision(2) << 0.00 << "]"; //append the first vertex (always has value of 0.0)
 
         float weight = 0.0;
 
         for (int i = 1; i < static_cast<int>(path.size()); i++) { //append remaining vertices to string (static cast is to convert unsigned long int to int)
-            weight += graph.getEdgeWeight(path[i-1], path[i]); //add edge weight to total weight
+            weight += graph.getEdgeWeight(path[i-1], path[i], pinned); //add edge weight to total weight
             result << "==>[" << setw(2) << path[i] << ":" << setw(6) << fixed << setprecision(2) << weight << "]"; //append vertex to stream
 
         }
         result << endl;
     }
+    graph.unpinSnapshot(pinned);
     string string = result.str(); //convert stream to string
     return string;
 }
 
 void startFile(MatrixGraph& graph, string filename, bool weighted) { //writes to file 
     ofstream outputFile(filename); //open output file stream
+    snapshot pinned = graph.pinSnapshot(); //header and edges all come from the same version
 
-    outputFile << graph.getVertices() << " " << graph.getEdges() << endl; //places vertex and edge count at header
+    outputFile << graph.getVertices() << " " << graph.getEdges(pinned) << endl; //places vertex and edge count at header
 
     if (weighted) { //weighted graph formatting
         for (int i = 1; i <= graph.getVertices(); i++) {
             for (int j = 1; j <= graph.getVertices(); j++) {
-                if (graph.getEdgeWeight(i,j) != 0.0) {
-                    outputFile << i << " " << j << " " << fixed << setprecision(6) << graph.getEdgeWeight(i, j) << endl; //creates line for each edge
+                if (graph.getEdgeWeight(i, j, pinned) != 0.0) {
+                    outputFile << i << " " << j << " " << fixed << setprecision(6) << graph.getEdgeWeight(i, j, pinned) << endl; //creates line for each edge
                 }
             }
         }
     } else { //unweighted graph formatting
         for (int i = 1; i <= graph.getVertices(); i++) {
             for (int j = 1; j <= graph.getVertices(); j++) {
-                if (graph.getEdgeWeight(i,j) != 0.0) {
+                if (graph.getEdgeWeight(i, j, pinned) != 0.0) {
                     outputFile << i << " " << j << endl; //creates line for each edge
                 }
             }
         }
     outputFile.close(); //close file
     }
+    graph.unpinSnapshot(pinned);
 }
 
-string dijkstraSingle(MatrixGraph& graph) { //returns dijkstra path between two given vertices within a string
-    int start;
-    int end;
+string dijkstraSingle(MatrixGraph& graph, int start, int end) { //returns dijkstra path between two given vertices within a string
     stringstream result;
+    snapshot pinned = graph.pinSnapshot(); //path and weights all come from the same version
 
-    cin >> start >> end; //get user input of vertices
-
-    vector<int> path = graph.getDijkstraPath(start, end); //generate vector of path between vertices
+    vector<int> path = graph.getDijkstraPath(start, end, pinned); //generate vector of path between vertices
 
     if (path.empty()) { //prints error message if no path is found between given vertices
         result << "No DIJKSTRA path from " << start << " to " << end << "." << endl;
@@ -98,23 +97,22 @@ string dijkstraSingle(MatrixGraph& graph) { //returns dijkstra path between two
         float weight = 0.0;
 
         for (int i = 1; i < static_cast<int>(path.size()); i++) { //append remaining vertices to string (static cast is to convert unsigned long int to int)
-            weight += graph.getEdgeWeight(path[i-1], path[i]); //add edge weight to total weight
+            weight += graph.getEdgeWeight(path[i-1], path[i], pinned); //add edge weight to total weight
             result << "==>[" << setw(2) << path[i] << ":" << setw(6) << fixed << setprecision(2) << weight << "]"; //append vertex to stream
 
         }
         result << endl;
     }
+    graph.unpinSnapshot(pinned);
     string string = result.str(); //convert stream to string
     return string;
 }
 
-string dijkstraAll(MatrixGraph& graph) { //returns dijkstra paths to all vertices of a given vertex within a string
-    int vertex;
+string dijkstraAll(MatrixGraph& graph, int vertex) { //returns dijkstra paths to all vertices of a given vertex within a string
     stringstream result;
+    snapshot pinned = graph.pinSnapshot(); //paths and weights all come from the same version
 
-    cin >> vertex; //collect user input of vertex
-
-    vector<vector<int>> paths = graph.getDijkstraAll(vertex); //generate vector of vectors to all vertices
+    vector<vector<int>> paths = graph.getDijkstraAll(vertex, pinned); //generate vector of vectors to all vertices
 
     for (int i = 1; i <= graph.getVertices(); i++) { //for each vertex
         if (i == vertex) { //prints distinguishing message if matching the input vertex
@@ -129,7 +127,7 @@ string dijkstraAll(MatrixGraph& graph) { //returns dijkstra paths to all vertice
                     float weight = 0.0; //initialize weight of path to 0
 
                     for (int j = 1; j < static_cast<int>(paths[i-1].size()); j++) { //append remaining vertices to string (static cast is to convert unsigned long int to int)
-                        weight += graph.getEdgeWeight(paths[i-1][j-1], paths[i-1][j]); //add edge weight to total weight
+                        weight += graph.getEdgeWeight(paths[i-1][j-1], paths[i-1][j], pinned); //add edge weight to total weight
                         result << "==>[" << setw(2) << paths[i-1][j] << ":" << setw(6) << fixed << setprecision(2) << weight << "]"; //append vertex to stream
 
                     }
@@ -137,10 +135,64 @@ string dijkstraAll(MatrixGraph& graph) { //returns dijkstra paths to all vertice
                 }
         }
     }
+    graph.unpinSnapshot(pinned);
     string string = result.str(); //convert stream to string
     return string;
 }
 
+string answerRequest(MatrixGraph& graph, const string& line) { //returns response to one server request line
+    stringstream request(line);
+    string command;
+    request >> command;
+
+    int count; //number of vertices the command takes
+    if (command == "PING") { //PING
+        count = 0;
+    } else if (command == "ALL") { //ALL <vertex>
+        count = 1;
+    } else if (command == "BFS" || command == "DIJKSTRA") { //BFS <start> <end>, DIJKSTRA <start> <end>
+        count = 2;
+    } else {
+        return "ERR unknown command\n";
+    }
+
+    int vertex[2];
+    for (int i = 0; i < count; i++) { //each argument must parse as a whole number
+        if (!(request >> vertex[i])) {
+            return count == 1 ? "ERR expected 1 vertex\n" : "ERR expected 2 vertices\n";
+        }
+    }
+
+    string extra;
+    if (request >> extra) { //rejects trailing text, including the rest of something like 1x
+        return "ERR unexpected argument " + extra + "\n";
+    }
+
+    for (int i = 0; i < count; i++) {
+        if (vertex[i] < 1 || vertex[i] > graph.getVertices()) {
+            return "ERR invalid vertex\n";
+        }
+    }
+
+    if (command == "PING") { //lets clients check that the server is up
+        return "PONG\n";
+    }
+    if (command == "ALL") {
+        return dijkstraAll(graph, vertex[0]);
+    }
+    if (command == "BFS") {
+        return findPath(graph, vertex[0], vertex[1]);
+    }
+    return dijkstraSingle(graph, vertex[0], vertex[1]);
+}
+
+GraphServer* activeServer = nullptr; //server stopped by signalHandler
+
+void signalHandler(int signalNumber) { //stops server so the socket file is cleaned up
+    if (activeServer != nullptr) {
+        activeServer->stop();
+    }
+}
 
 int main(int argc, char* argv[]) {
 
@@ -148,13 +200,34 @@ int main(int argc, char* argv[]) {
     string filePath = argv[2]; //collect file path name
     bool weighted = true; //weighted by default
     bool directed = true; //directed by default
+    string tileFile; //empty unless graph is stored out of core
+    int tileSize = 256; //default 256x256 tiles (256KB each)
+    int cacheTiles = 1024; //default cache budget of 1024 tiles (256MB)
+    bool versioned = false; //copy on write storage for concurrent queries
+    string socketPath; //empty unless graph is served over a socket
+    int workerCount = thread::hardware_concurrency(); //one worker per core by default
     
     if (arg1 == "-u") { //sets weighted boolean based on first argument
         weighted = false;
     }
 
-    if (argc == 4) { //sets directed to true if [-ud] argument is present
-        directed = false;
+    for (int i = 3; i < argc; i++) { //collects optional arguments
+        string option = argv[i];
+        if (option == "-ud") { //sets directed to false if [-ud] argument is present
+            directed = false;
+        } else if (option == "-tiled" && i + 1 < argc) { //stores matrix as tiles within given file
+            tileFile = argv[++i];
+        } else if (option == "-tilesize" && i + 1 < argc) { //rows and columns per tile
+            tileSize = stoi(argv[++i]);
+        } else if (option == "-cache" && i + 1 < argc) { //max tiles held in memory at once
+            cacheTiles = stoi(argv[++i]);
+        } else if (option == "-versioned") { //stores matrix as copy on write versions
+            versioned = true;
+        } else if (option == "-serve" && i + 1 < argc) { //answers requests over given unix socket instead of the menu
+            socketPath = argv[++i];
+        } else if (option == "-workers" && i + 1 < argc) { //number of threads answering requests
+            workerCount = stoi(argv[++i]);
+        }
     }
 
     ifstream file(filePath); //create input file stream
@@ -167,12 +240,26 @@ int main(int argc, char* argv[]) {
 
     stream >> vertices >> edges; //collects vertex and edge count from file
 
-    MatrixGraph graph = MatrixGraph(vertices, directed); //constructor for graph
+    MatrixGraph* graphPointer; //tiled graphs keep matrix within a file instead of memory
+    if (versioned) {
+        graphPointer = new MatrixGraph(vertices, directed, 64, max(workerCount, 1) + 1); //constructor for versioned graph with 64 row blocks, readers are the workers plus the main thread
+    } else if (tileFile.empty()) {
+        graphPointer = new MatrixGraph(vertices, directed); //constructor for graph
+    } else {
+        try {
+            graphPointer = new MatrixGraph(vertices, directed, tileFile, tileSize, cacheTiles); //constructor for tiled graph
+        } catch (exception& error) { //prints error message if tile file cannot be created
+            cout << error.what() << endl;
+            return 1;
+        }
+    }
+    MatrixGraph& graph = *graphPointer;
 
     int start; //instance variables for collecting data from file
     int end;
     float weight;
 
+    graph.beginBatch(); //whole file is published as a single version
     if (weighted) { //if weighted
         for (int i = 0; i < edges; i++) {
             file >> start >> end >> weight; //collects start end and weight
@@ -185,8 +272,37 @@ int main(int argc, char* argv[]) {
             graph.addEdge(start, end, 1); //creates edge
         }
     }
+    graph.commitBatch();
     file.close(); //closes file
 
+    if (!socketPath.empty()) { //graph is loaded once and then shared by every request
+        mutex tileLock; //tile cache is not thread safe, so tiled graphs answer one request at a time
+        GraphServer* server;
+        try {
+            server = new GraphServer(socketPath, workerCount, [&graph, &tileLock](const string& line) {
+                if (graph.isTiled()) {
+                    lock_guard<mutex> lock(tileLock);
+                    return answerRequest(graph, line);
+                }
+                return answerRequest(graph, line);
+            });
+        } catch (exception& error) { //prints error message if socket path is taken
+            cout << error.what() << endl;
+            delete graphPointer;
+            return 1;
+        }
+
+        activeServer = server;
+        signal(SIGINT, signalHandler);
+        signal(SIGTERM, signalHandler);
+        server->run(); //returns once a signal stops the server
+        activeServer = nullptr;
+
+        delete server; //closes socket and removes socket file
+        delete graphPointer; //clean graph
+        return 0;
+    }
+
     int choice;
     string filename;
 
@@ -199,13 +315,16 @@ int main(int argc, char* argv[]) {
                 cout << graph.toString(); //prints graph
                 break;
             case 2:
-                cout << findPath(graph); //prints path between given vertices
+                cin >> start >> end; //get user input of vertices
+                cout << findPath(graph, start, end); //prints path between given vertices
                 break;
             case 3:
-                cout << dijkstraSingle(graph); //prints single Dijkstra path between two vertices
+                cin >> start >> end; //get user input of vertices
+                cout << dijkstraSingle(graph, start, end); //prints single Dijkstra path between two vertices
                 break;
             case 4:
-                cout << dijkstraAll(graph); //prints Dijkstra path to all vertices with a given vertex
+                cin >> start; //collect user input of vertex
+                cout << dijkstraAll(graph, start); //prints Dijkstra path to all vertices with a given vertex
                 break;
             case 5:
                 cin >> filename; //collects file name
@@ -216,7 +335,8 @@ int main(int argc, char* argv[]) {
                     cout << "No file has been created yet." << endl;
                 } else {
                     ofstream outputFile(filename, ios::app); //opens file
-                    outputFile << findPath(graph); //appends path to file
+                    cin >> start >> end; //get user input of vertices
+                    outputFile << findPath(graph, start, end); //appends path to file
                     outputFile.close(); //close file
                 }
                 break;
@@ -225,7 +345,8 @@ int main(int argc, char* argv[]) {
                     cout << "No file has been created yet." << endl;
                 } else {
                     ofstream outputFile(filename, ios::app); //opens file
-                    outputFile << dijkstraSingle(graph); //appends path to file
+                    cin >> start >> end; //get user input of vertices
+                    outputFile << dijkstraSingle(graph, start, end); //appends path to file
                     outputFile.close(); //close file
                 }
                 break;
@@ -234,17 +355,24 @@ int main(int argc, char* argv[]) {
                     cout << "No file has been created yet." << endl;
                 } else {
                     ofstream outputFile(filename, ios::app); //opens file
-                    outputFile << dijkstraAll(graph); //appends all paths to file
+                    cin >> start; //collect user input of vertex
+                    outputFile << dijkstraAll(graph, start); //appends all paths to file
                     outputFile.close(); //close file
                 }
                 break;
             case 9999:
                 graph.printRaw(); //prints raw 2d array of graph
                 break;
+            case 9998:
+                cout << "Tile faults: " << graph.getTileFaults() //prints tile cache counters
+                     << "\nBytes mapped: " << graph.getBytesMapped() << endl;
+                break;
             default:
                 if (choice != 0) cout << "Invalid option. Please try again.\n"; //error message if option not listed
                 break;
         }
     } while (choice != 0); //loops ends when user inputs 0 to quit
+
+    delete graphPointer; //clean graph
     return 0;
 }
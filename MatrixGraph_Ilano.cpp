@@ -9,8 +9,91 @@ Description: Definitions for the Matrix Graph Class with Dijkstra Algorithm func
 #include "MatrixGraph_Ilano.h"
 #include <iostream>
 #include <iomanip>
+#include <limits>
+#include <cmath>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 using namespace std;
 
+static int maskedArgmin(const float* distance, const int* open, int count) { //returns closest unvisited vertex (lowest index on ties), -1 if none are reachable
+    const float infinity = numeric_limits<float>::infinity();
+    float best = infinity;
+    int i = 0;
+
+#ifdef __SSE2__
+    __m128 infinityVector = _mm_set1_ps(infinity);
+    __m128 minimum = infinityVector;
+    for (; i + 4 <= count; i += 4) { //visited vertices are blended to infinity before taking the min
+        __m128 mask = _mm_castsi128_ps(_mm_loadu_si128((const __m128i*)(open + i)));
+        __m128 masked = _mm_or_ps(_mm_and_ps(mask, _mm_loadu_ps(distance + i)), _mm_andnot_ps(mask, infinityVector));
+        minimum = _mm_min_ps(minimum, masked);
+    }
+    minimum = _mm_min_ps(minimum, _mm_shuffle_ps(minimum, minimum, _MM_SHUFFLE(2, 3, 0, 1))); //reduce 4 lanes to 1
+    minimum = _mm_min_ps(minimum, _mm_shuffle_ps(minimum, minimum, _MM_SHUFFLE(1, 0, 3, 2)));
+    best = _mm_cvtss_f32(minimum);
+#endif
+
+    for (; i < count; i++) { //remaining vertices that do not fill a vector
+        if (open[i] && distance[i] < best) {
+            best = distance[i];
+        }
+    }
+
+    if (best == infinity) { //every unvisited vertex is unreachable
+        return -1;
+    }
+
+    i = 0;
+#ifdef __SSE2__
+    __m128 target = _mm_set1_ps(best);
+    for (; i + 4 <= count; i += 4) { //first unvisited lane equal to the min
+        __m128 mask = _mm_castsi128_ps(_mm_loadu_si128((const __m128i*)(open + i)));
+        int lanes = _mm_movemask_ps(_mm_and_ps(mask, _mm_cmpeq_ps(_mm_loadu_ps(distance + i), target)));
+        if (lanes != 0) {
+            return i + __builtin_ctz(lanes);
+        }
+    }
+#endif
+
+    for (; i < count; i++) {
+        if (open[i] && distance[i] == best) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void relaxRow(const float* row, float* distance, int* parent, const int* open, int u, int count) { //relaxes every edge leaving u
+    float base = distance[u];
+    int i = 0;
+
+#ifdef __SSE2__
+    __m128 baseVector = _mm_set1_ps(base);
+    __m128 zero = _mm_setzero_ps();
+    __m128i parentVector = _mm_set1_epi32(u);
+    for (; i + 4 <= count; i += 4) { //lanes with an edge, an unvisited vertex, and a shorter path take the new values
+        __m128 weight = _mm_loadu_ps(row + i);
+        __m128 current = _mm_loadu_ps(distance + i);
+        __m128 candidate = _mm_add_ps(baseVector, weight);
+        __m128 mask = _mm_and_ps(_mm_cmpneq_ps(weight, zero), _mm_cmplt_ps(candidate, current));
+        mask = _mm_and_ps(mask, _mm_castsi128_ps(_mm_loadu_si128((const __m128i*)(open + i))));
+        _mm_storeu_ps(distance + i, _mm_or_ps(_mm_and_ps(mask, candidate), _mm_andnot_ps(mask, current)));
+
+        __m128i maskInt = _mm_castps_si128(mask);
+        __m128i oldParent = _mm_loadu_si128((const __m128i*)(parent + i));
+        _mm_storeu_si128((__m128i*)(parent + i), _mm_or_si128(_mm_and_si128(maskInt, parentVector), _mm_andnot_si128(maskInt, oldParent)));
+    }
+#endif
+
+    for (; i < count; i++) { //remaining vertices that do not fill a vector
+        if (open[i] && row[i] != 0.0 && base + row[i] < distance[i]) {
+            distance[i] = base + row[i];
+            parent[i] = u;
+        }
+    }
+}
+
 MatrixGraph::MatrixGraph(int vertices, bool directed) { //constructor
     array = new float*[vertices]; //creates first array
     for (int i = 0; i < vertices; i++) { //creates array for each index
@@ -19,9 +102,41 @@ MatrixGraph::MatrixGraph(int vertices, bool directed) { //constructor
     this->directed = directed;
     this->vertices = vertices;
     edges = 0; //initialize edges to 0
+    tiled = nullptr; //matrix is stored in memory
+    versioned = nullptr;
+}
+
+MatrixGraph::MatrixGraph(int vertices, bool directed, string filePath, int tileSize, int cacheTiles) { //constructor for graphs larger than memory
+    tiled = new TiledMatrix(vertices, filePath, tileSize, cacheTiles); //matrix is stored as tiles within file
+    versioned = nullptr;
+    array = nullptr;
+    this->directed = directed;
+    this->vertices = vertices;
+    edges = 0; //initialize edges to 0
+}
+
+MatrixGraph::MatrixGraph(int vertices, bool directed, int blockRows, int readerThreads) { //constructor for graphs updated while being queried
+    versioned = new VersionedMatrix(vertices, directed, blockRows, 2 * readerThreads); //matrix is stored as copy on write row blocks, two slots per thread covers a query pinning inside another
+    tiled = nullptr;
+    array = nullptr;
+    this->directed = directed;
+    this->vertices = vertices;
+    edges = 0; //edge count is kept within each version instead
 }
 
 MatrixGraph::~MatrixGraph() { //destructor
+    if (tiled != nullptr) { //unmaps tiles and closes file
+        delete tiled;
+        tiled = nullptr;
+        return;
+    }
+
+    if (versioned != nullptr) { //deletes every remaining version
+        delete versioned;
+        versioned = nullptr;
+        return;
+    }
+
     for (int i = 0; i < vertices; i++) { //deletes array at each index
         delete[] array[i];
     }
@@ -29,37 +144,103 @@ MatrixGraph::~MatrixGraph() { //destructor
     array = nullptr;
 }
 
+float MatrixGraph::cell(int start, int end) { //returns value at 0 based vertices
+    if (tiled != nullptr) {
+        return tiled->get(start, end);
+    }
+    if (versioned != nullptr) { //reads from latest version
+        return versioned->get(start, end);
+    }
+    return array[start][end];
+}
+
+void MatrixGraph::setCell(int start, int end, float weight) { //sets value at 0 based vertices
+    if (tiled != nullptr) {
+        tiled->set(start, end, weight);
+    } else {
+        array[start][end] = weight;
+    }
+}
+
+snapshot MatrixGraph::pinSnapshot() { //pins latest version so a query never sees a partial update
+    if (versioned == nullptr) {
+        return {nullptr, -1};
+    }
+    return versioned->pin();
+}
+
+void MatrixGraph::unpinSnapshot(snapshot pinned) { //releases version pinned by pinSnapshot
+    if (versioned != nullptr) {
+        versioned->unpin(pinned);
+    }
+}
+
+const float* MatrixGraph::getRow(int row, float* buffer, snapshot pinned) { //returns all edges leaving a 0 based vertex
+    if (tiled != nullptr) { //tiles are copied into buffer since row is not contiguous in file
+        tiled->readRow(row, buffer);
+        return buffer;
+    }
+    if (versioned != nullptr) { //row within pinned version
+        return versioned->getRow(pinned, row);
+    }
+    return array[row];
+}
+
 
 void MatrixGraph::addEdge(int start, int end, float weight) { //adds corresponding values to array to represent edge
-    if (array[start-1][end-1] == 0.0) { //increments edge count if edge is new
+    if (versioned != nullptr) { //published as a new version
+        versioned->addEdge(start-1, end-1, weight);
+        return;
+    }
+
+    if (cell(start-1, end-1) == 0.0) { //increments edge count if edge is new
         edges++;
     }
 
-    array[start-1][end-1] = weight; //set value at given vertices
+    setCell(start-1, end-1, weight); //set value at given vertices
 
     if (!directed) { //add mirroring edge for undirected graphs
-        array[end-1][start-1] = weight;
+        setCell(end-1, start-1, weight);
     }
 }
 
 void MatrixGraph::removeEdge(int start, int end) { //removes edge by reassigning value to 0
-    array[start-1][end-1] = 0.0; //reassign edge to 0
+    if (versioned != nullptr) { //published as a new version
+        versioned->removeEdge(start-1, end-1);
+        return;
+    }
+
+    setCell(start-1, end-1, 0.0); //reassign edge to 0
 
     if (!directed) {
-        array[end-1][start-1] = 0.0; //reassign mirroring edge to 0
+        setCell(end-1, start-1, 0.0); //reassign mirroring edge to 0
     }
     edges--; //decrement count of edges
 }
 
 bool MatrixGraph::adjacent(int start, int end) { //returns true if value is found between two vertices
-    if (array[start-1][end-1] != 0.0 || array[end-1][start-1] != 0.0) { //if value is found return true
+    if (versioned != nullptr) { //both directions are read from the same version
+        snapshot pinned = pinSnapshot();
+        bool found = versioned->getRow(pinned, start-1)[end-1] != 0.0 || versioned->getRow(pinned, end-1)[start-1] != 0.0;
+        unpinSnapshot(pinned);
+        return found;
+    }
+
+    if (cell(start-1, end-1) != 0.0 || cell(end-1, start-1) != 0.0) { //if value is found return true
         return true;
     }
     return false; //defaults to false
 }
 
 float MatrixGraph::getEdgeWeight(int start, int end) { //returns value at given vertices
-    return array[start-1][end-1];
+    return cell(start-1, end-1);
+}
+
+float MatrixGraph::getEdgeWeight(int start, int end, snapshot pinned) { //returns value at given vertices within pinned version
+    if (versioned != nullptr) {
+        return versioned->getRow(pinned, start-1)[end-1];
+    }
+    return cell(start-1, end-1);
 }
 
 int MatrixGraph::getVertices() { //getter for vertices
@@ -67,52 +248,87 @@ int MatrixGraph::getVertices() { //getter for vertices
 }
 
 int MatrixGraph::getEdges() { //getter for edges
+    if (versioned != nullptr) { //edge count of latest version
+        return versioned->getEdges();
+    }
+    return edges;
+}
+
+int MatrixGraph::getEdges(snapshot pinned) { //edge count within pinned version
+    if (versioned != nullptr) {
+        return pinned.version->edges;
+    }
     return edges;
 }
 
 void MatrixGraph::setEdgeWeight(int start, int end, float weight) { //reassigns value at given vertices
-    array[start-1][end-1] = weight; //reassign weight at given vertices
+    if (versioned != nullptr) { //published as a new version
+        versioned->setEdgeWeight(start-1, end-1, weight);
+        return;
+    }
+
+    setCell(start-1, end-1, weight); //reassign weight at given vertices
 
     if (!directed) { 
-        array[end-1][start-1] = weight; //reassign weight at mirroring vertices if undirected
+        setCell(end-1, start-1, weight); //reassign weight at mirroring vertices if undirected
     }
 }
 
 string MatrixGraph::toString() { //returns string representation of graph
     ostringstream stream;
+    float* buffer = tiled != nullptr ? new float[vertices] : nullptr; //row buffer only needed for tiled storage
+    snapshot pinned = pinSnapshot();
 
     for (int i = 1; i <= vertices; i++) {
         stream << "[" << setw(2) << i << "]:"; //leading title for each vertex
+        const float* row = getRow(i-1, buffer, pinned);
 
         for (int j = 1; j <= vertices; j++) { //for entire array within index
-            if (array[i-1][j-1] != 0.0) {
+            if (row[j-1] != 0.0) {
                 stream << "-->[" << setw(2) << i << "," << setw(2) << j //appends to for each edge
-                       << "::" << setw(6) << fixed << setprecision(2) << array[i-1][j-1] << "]";
+                       << "::" << setw(6) << fixed << setprecision(2) << row[j-1] << "]";
             }
         }
 
         stream << endl; //create new line for next vertex
     }
+
+    unpinSnapshot(pinned);
+    delete[] buffer; //clean buffer
     return stream.str(); //return string of stream
 }
 
 void MatrixGraph::printRaw() { //prints 2d array directly
     cout << "Adjacency Matrix:\n\n";
+    float* buffer = tiled != nullptr ? new float[vertices] : nullptr; //row buffer only needed for tiled storage
+    snapshot pinned = pinSnapshot();
 
     for (int i = 0; i < vertices; i++) { //for each vertex
+        const float* row = getRow(i, buffer, pinned);
         for (int j = 0; j < vertices; j++) { //for each index within each vertex
-            cout << fixed << setprecision(2) << setw(7) << array[i][j]; //prints float value
+            cout << fixed << setprecision(2) << setw(7) << row[j]; //prints float value
         }
         cout << endl; //new line for next row
     }
+
+    unpinSnapshot(pinned);
+    delete[] buffer; //clean buffer
 }
 
 bool MatrixGraph::pathExists(int start, int end) { //returns a boolean that represents if a path exists between two vertices
+    snapshot pinned = pinSnapshot(); //whole search runs against one version
+    bool found = pathExists(start, end, pinned);
+    unpinSnapshot(pinned);
+    return found;
+}
+
+bool MatrixGraph::pathExists(int start, int end, snapshot pinned) { //pathExists within pinned version
 
     start--; //modify values for 0 based indexing
     end--;
 
     bool* visited = new bool[vertices](); //initialize all values to false
+    float* buffer = tiled != nullptr ? new float[vertices] : nullptr; //row buffer only needed for tiled storage
     Queue<int> queue;
 
     queue.enqueue(start); //queue start vertex
@@ -121,11 +337,13 @@ bool MatrixGraph::pathExists(int start, int end) { //returns a boolean that repr
     while (!queue.isEmpty()) { //until no more edges are found
         int curr = queue.front(); //saves first item in queue
         queue.dequeue(); //removes first item
+        const float* row = getRow(curr, buffer, pinned);
 
         for (int i = 0; i < vertices; i++) { //loops through sub array of current vertex
-            if (array[curr][i] != 0.0 && !visited[i]) { //if edge is found and vertex is not visited
+            if (row[i] != 0.0 && !visited[i]) { //if edge is found and vertex is not visited
                 if (i == end) { //returns true if end edge match is found
-                    delete[] visited; //clean array
+                    delete[] visited; //clean arrays
+                    delete[] buffer;
                     return true; 
                 }
                 queue.enqueue(i); //enqueue edges found connected from current item
@@ -134,17 +352,26 @@ bool MatrixGraph::pathExists(int start, int end) { //returns a boolean that repr
         }
     }
 
-    delete[] visited; //clean array
+    delete[] visited; //clean arrays
+    delete[] buffer;
     return false; //defaults to false if path is not found
 }
 
 vector<int> MatrixGraph::getBFSPath(int start, int end) { //returns vector of path between two vertices
+    snapshot pinned = pinSnapshot(); //whole search runs against one version
+    vector<int> path = getBFSPath(start, end, pinned);
+    unpinSnapshot(pinned);
+    return path;
+}
+
+vector<int> MatrixGraph::getBFSPath(int start, int end, snapshot pinned) { //getBFSPath within pinned version
 
     start--; //modify values for 0 based indexing
     end--;
 
     bool* visited = new bool[vertices](); //initialize all values to false
     int* parent = new int[vertices]; //create array of parents to recontruct path
+    float* buffer = tiled != nullptr ? new float[vertices] : nullptr; //row buffer only needed for tiled storage
 
     for(int i = 0; i < vertices; i++) { //initialize all values in parent array to -1
         parent[i] = -1;
@@ -158,9 +385,10 @@ vector<int> MatrixGraph::getBFSPath(int start, int end) { //returns vector of pa
     while (!queue.isEmpty() && !pathFound) { //while queue is not empty and path is not found
         int curr = queue.front(); //save vertex at front of queue
         queue.dequeue(); //dequeue first item
+        const float* row = getRow(curr, buffer, pinned);
 
         for (int i = 0; i < vertices; i++) { //loops through sub array of vertex
-            if (array[curr][i] != 0.0 && !visited[i]) { //if edge is found and not visited yet
+            if (row[i] != 0.0 && !visited[i]) { //if edge is found and not visited yet
                 parent[i] = curr; //mark current in parent array
                 if (i == end) { //if end vertex is found
                     pathFound = true; //mark path as found
@@ -184,11 +412,55 @@ vector<int> MatrixGraph::getBFSPath(int start, int end) { //returns vector of pa
 
     delete[] visited; //clean arrays
     delete[] parent;
+    delete[] buffer;
 
     return path; //return path vector
 }
 
 vector<int> MatrixGraph::getDijkstraPath(int start, int end) {
+    snapshot pinned = pinSnapshot(); //whole search runs against one version
+    vector<int> path = getDijkstraPath(start, end, pinned);
+    unpinSnapshot(pinned);
+    return path;
+}
+
+bool MatrixGraph::isDense(snapshot pinned) { //true when heap work (E log V) would exceed array work (V^2)
+    //equal cost paths may differ from the heap variant since ties go to the lowest vertex instead of heap order
+    long long count = pinned.version != nullptr ? pinned.version->edges : edges;
+    if (!directed) { //undirected edges fill two entries
+        count *= 2;
+    }
+    return count * log2(max(vertices, 2)) >= (double)vertices * vertices;
+}
+
+void MatrixGraph::denseDijkstra(int start, int end, int* parent, snapshot pinned) { //array based dijkstra, stops early once end is visited
+    float* distance = new float[vertices]; //store distances from start to each vertex
+    int* open = new int[vertices]; //all bits set while unvisited so it can be used as a vector mask
+    float* buffer = tiled != nullptr ? new float[vertices] : nullptr; //row buffer only needed for tiled storage
+
+    for (int i = 0; i < vertices; i++) { //initialize single source
+        distance[i] = numeric_limits<float>::infinity(); //v.d = inf
+        parent[i] = -1; //v.pi = NIL
+        open[i] = -1;
+    }
+    distance[start] = 0.0; //s.d = 0 since same starting node
+
+    int u = maskedArgmin(distance, open, vertices);
+    while (u != -1) { //until no reachable vertices are left
+        open[u] = 0; //mark vertex as visited
+        if (u == end) { //path to end is final once visited
+            break;
+        }
+        relaxRow(getRow(u, buffer, pinned), distance, parent, open, u, vertices);
+        u = maskedArgmin(distance, open, vertices);
+    }
+
+    delete[] distance; //clean arrays
+    delete[] open;
+    delete[] buffer;
+}
+
+vector<int> MatrixGraph::getDijkstraPath(int start, int end, snapshot pinned) {
     if (start == end) { //return empty array if same start and end
         return vector<int>();
     }
@@ -196,13 +468,31 @@ vector<int> MatrixGraph::getDijkstraPath(int start, int end) {
     start--; //decrement for 0 based indexing
     end--;
 
+    if (isDense(pinned)) { //no heap needed for near complete graphs
+        int* parent = new int[vertices];
+        denseDijkstra(start, end, parent, pinned);
+
+        vector<int> path; //instantiate vector for return
+        if (parent[end] != -1) { //end was reached
+            int curr = end; //starts at end of path
+            while (curr != -1) { //loop until no parents are left
+                path.insert(path.begin(), curr + 1); // insert parent incrementing by 1 for one based indexing
+                curr = parent[curr]; //move to parent of current index
+            }
+        }
+
+        delete[] parent; //clean array
+        return path;
+    }
+
     float* distance = new float[vertices]; //store distances from start to each vertex
     int* parent = new int[vertices]; //store parent vertices
     bool* visited = new bool[vertices](); //initialize all values to false
+    float* buffer = tiled != nullptr ? new float[vertices] : nullptr; //row buffer only needed for tiled storage
     bool pathFound = false; //defaults to false since path not found yet
    
     for(int i = 0; i < vertices; i++) { //initialize single source
-        distance[i] = 999999; //v.d = inf
+        distance[i] = numeric_limits<float>::infinity(); //v.d = inf, same as dense mode so the switch never changes reachability
         parent[i] = -1; //v.pi = NIL
     }
     distance[start] = 0.0; //s.d = 0 since same starting node
@@ -221,10 +511,11 @@ vector<int> MatrixGraph::getDijkstraPath(int start, int end) {
         }
 
         visited[u] = true; //mark vertex as visited
+        const float* row = getRow(u, buffer, pinned);
         
         for (int i = 0; i < vertices; i++) { //for all edges adjacent to vertex
-            if (array[u][i] != 0.0 && distance[i] > distance[u] + array[u][i]) { //relax
-                distance[i] = distance[u] + array[u][i]; //reassign distance if shorter path
+            if (row[i] != 0.0 && distance[i] > distance[u] + row[i]) { //relax
+                distance[i] = distance[u] + row[i]; //reassign distance if shorter path
                 parent[i] = u; //reassign parent
                 priorityQueue.enqueue(i, distance[i]); //enqueue 
             }
@@ -244,14 +535,75 @@ vector<int> MatrixGraph::getDijkstraPath(int start, int end) {
     delete[] distance; //clean arrays
     delete[] parent;
     delete[] visited;
+    delete[] buffer;
 
     return path;
 }
 
 vector<vector<int>> MatrixGraph::getDijkstraAll(int vertex) {
+    snapshot pinned = pinSnapshot(); //every path comes from the same version
+    vector<vector<int>> paths = getDijkstraAll(vertex, pinned);
+    unpinSnapshot(pinned);
+    return paths;
+}
+
+vector<vector<int>> MatrixGraph::getDijkstraAll(int vertex, snapshot pinned) { //getDijkstraAll within pinned version
     vector<vector<int>> paths(vertices, vector<int>());
+
+    if (isDense(pinned)) { //one pass gives the parent of every vertex
+        int* parent = new int[vertices];
+        denseDijkstra(vertex - 1, -1, parent, pinned);
+
+        for (int i = 0; i < vertices; i++) {
+            if (i != vertex - 1 && parent[i] != -1) { //start vertex and unreached vertices stay empty
+                int curr = i; //starts at end of path
+                while (curr != -1) { //loop until no parents are left
+                    paths[i].insert(paths[i].begin(), curr + 1); // insert parent incrementing by 1 for one based indexing
+                    curr = parent[curr]; //move to parent of current index
+                }
+            }
+        }
+
+        delete[] parent; //clean array
+        return paths;
+    }
+
     for (int i = 0; i < vertices; i++) {
-        paths[i] = getDijkstraPath(vertex, i + 1);
+        paths[i] = getDijkstraPath(vertex, i + 1, pinned);
     }
     return paths;
+}
+
+bool MatrixGraph::isTiled() { //returns true if matrix is stored out of core
+    return tiled != nullptr;
+}
+
+bool MatrixGraph::isVersioned() { //returns true if matrix is stored as copy on write versions
+    return versioned != nullptr;
+}
+
+void MatrixGraph::beginBatch() { //holds following updates until commitBatch, no op unless versioned
+    if (versioned != nullptr) {
+        versioned->beginBatch();
+    }
+}
+
+void MatrixGraph::commitBatch() { //publishes held updates as one version, no op unless versioned
+    if (versioned != nullptr) {
+        versioned->commitBatch();
+    }
+}
+
+long long MatrixGraph::getTileFaults() { //getter for tile faults, 0 for in memory graphs
+    if (tiled == nullptr) {
+        return 0;
+    }
+    return tiled->getTileFaults();
+}
+
+long long MatrixGraph::getBytesMapped() { //getter for bytes mapped from tile file, 0 for in memory graphs
+    if (tiled == nullptr) {
+        return 0;
+    }
+    return tiled->getBytesMapped();
 }
\ No newline at end of file
@@ -9,6 +9,8 @@ Description: Declarations for the Matrix Graph Class with Dijkstra declarations
 #include <vector>
 #include <string>
 #include <stdexcept>
+#include "TiledMatrix_Ilano.h"
+#include "VersionedMatrix_Ilano.h"
 using namespace std;
 
 class MatrixGraph {
@@ -17,9 +19,19 @@ private: //variable declarations
     int vertices;
     int edges;
     bool directed;
+    TiledMatrix* tiled; //out of core storage, nullptr when matrix is in memory
+    VersionedMatrix* versioned; //copy on write storage for concurrent readers, nullptr otherwise
+
+    float cell(int start, int end); //0 based access that works for every storage mode
+    void setCell(int start, int end, float weight);
+    const float* getRow(int row, float* buffer, snapshot pinned); //buffer is only filled for tiled storage
+    bool isDense(snapshot pinned); //picks array based dijkstra over heap based
+    void denseDijkstra(int start, int end, int* parent, snapshot pinned); //end of -1 finds every path
 
 public: //method declarations
     MatrixGraph(int vertices, bool directed);
+    MatrixGraph(int vertices, bool directed, string filePath, int tileSize, int cacheTiles);
+    MatrixGraph(int vertices, bool directed, int blockRows, int readerThreads);
     ~MatrixGraph();
     void addEdge(int start, int end, float weight);
     void removeEdge(int start, int end);
@@ -34,5 +46,19 @@ public: //method declarations
     vector<int> getBFSPath(int start, int end);
     vector<int> getDijkstraPath(int start, int end);
     vector<vector<int>> getDijkstraAll(int vertex);
+    snapshot pinSnapshot(); //pins latest version so several calls see the same graph, no op unless versioned
+    void unpinSnapshot(snapshot pinned);
+    int getEdges(snapshot pinned);
+    float getEdgeWeight(int start, int end, snapshot pinned);
+    bool pathExists(int start, int end, snapshot pinned);
+    vector<int> getBFSPath(int start, int end, snapshot pinned);
+    vector<int> getDijkstraPath(int start, int end, snapshot pinned);
+    vector<vector<int>> getDijkstraAll(int vertex, snapshot pinned);
+    bool isTiled();
+    bool isVersioned();
+    void beginBatch();
+    void commitBatch();
+    long long getTileFaults();
+    long long getBytesMapped();
 };
 #endif
\ No newline at end of file
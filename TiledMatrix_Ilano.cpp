@@ -0,0 +1,135 @@
+/*
+Author: Gabriel Ilano
+Date: 4/19/24
+Description: Definitions for the Tiled Matrix Class with an lru tile cache over a memory mapped file
+*/
+
+#include "TiledMatrix_Ilano.h"
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+using namespace std;
+
+TiledMatrix::TiledMatrix(int size, string filePath, int tileSize, int cacheTiles) { //constructor
+    if (size <= 0 || tileSize <= 0 || cacheTiles <= 0) { //throws exception if dimensions are invalid
+        throw invalid_argument("Invalid tiled matrix dimensions");
+    }
+
+    this->size = size;
+    this->tileSize = tileSize;
+    this->cacheTiles = cacheTiles;
+    tilesPerSide = (size + tileSize - 1) / tileSize; //round up so partial tiles cover the edges
+
+    long long pageSize = sysconf(_SC_PAGESIZE);
+    tileBytes = (long long)tileSize * tileSize * sizeof(float);
+    tileStride = (tileBytes + pageSize - 1) / pageSize * pageSize; //mmap offsets must be page aligned
+
+    fd = open(filePath.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600); //never reuse or truncate an existing file
+    if (fd == -1) {
+        throw runtime_error("Could not create tile file " + filePath + " (it must not already exist)");
+    }
+    unlink(filePath.c_str()); //file is removed right away and its space is freed once fd is closed, even on a crash
+
+    if (ftruncate(fd, (off_t)tilesPerSide * tilesPerSide * tileStride) == -1) { //sparse file, untouched tiles take no disk space
+        close(fd);
+        throw runtime_error("Could not size tile file " + filePath);
+    }
+
+    tileFaults = 0; //initialize counters to 0
+    bytesMapped = 0;
+    lastId = -1;
+    lastData = nullptr;
+}
+
+TiledMatrix::~TiledMatrix() { //destructor
+    while (!cache.empty()) { //unmaps every cached tile
+        evictTile();
+    }
+    close(fd);
+}
+
+float* TiledMatrix::getTile(long long id) { //returns mapped tile, mapping it on a cache miss
+    if (id == lastId) { //row scans hit the same tile repeatedly
+        return lastData;
+    }
+
+    auto found = cache.find(id);
+    if (found != cache.end()) { //cache hit moves tile to front of lru list
+        lru.splice(lru.begin(), lru, found->second.position);
+        lastId = id;
+        lastData = found->second.data;
+        return lastData;
+    }
+
+    if ((int)cache.size() >= cacheTiles) { //make room within cache budget
+        evictTile();
+    }
+
+    void* mapped = mmap(nullptr, tileBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, (off_t)id * tileStride);
+    if (mapped == MAP_FAILED) {
+        throw runtime_error("Could not map tile");
+    }
+
+    tileFaults++; //count tile fault and bytes mapped into the cache, actual disk reads happen lazily on first touch
+    bytesMapped += tileBytes;
+
+    lru.push_front(id);
+    cache[id] = {static_cast<float*>(mapped), lru.begin()};
+    lastId = id;
+    lastData = static_cast<float*>(mapped);
+    return lastData;
+}
+
+void TiledMatrix::evictTile() { //removes least recently used tile from cache
+    long long id = lru.back();
+    lru.pop_back();
+    munmap(cache[id].data, tileBytes); //shared mapping writes changes back to file
+    cache.erase(id);
+
+    if (id == lastId) { //reset fast lookup if it was evicted
+        lastId = -1;
+        lastData = nullptr;
+    }
+}
+
+float TiledMatrix::get(int row, int col) { //returns value at given row and column
+    float* data = getTile((long long)(row / tileSize) * tilesPerSide + col / tileSize);
+    return data[(long long)(row % tileSize) * tileSize + col % tileSize];
+}
+
+void TiledMatrix::set(int row, int col, float value) { //reassigns value at given row and column
+    float* data = getTile((long long)(row / tileSize) * tilesPerSide + col / tileSize);
+    data[(long long)(row % tileSize) * tileSize + col % tileSize] = value;
+}
+
+void TiledMatrix::readRow(int row, float* buffer) { //copies entire row into buffer one tile at a time
+    prefetchRow(row); //hint the whole row before the first tile is mapped
+
+    long long tileRow = (long long)(row / tileSize) * tilesPerSide;
+    long long offset = (long long)(row % tileSize) * tileSize; //start of row within each tile
+
+    for (int i = 0; i < tilesPerSide; i++) { //for each tile across the row
+        int columns = min(tileSize, size - i * tileSize); //last tile may be partial
+        memcpy(buffer + i * tileSize, getTile(tileRow + i) + offset, columns * sizeof(float));
+    }
+}
+
+void TiledMatrix::prefetchRow(int row) { //advises the kernel that the row will be read soon
+    long long tileRow = (long long)(row / tileSize) * tilesPerSide;
+    long long offset = (long long)(row % tileSize) * tileSize * sizeof(float);
+
+    for (int i = 0; i < tilesPerSide; i++) { //only the slice of the row within each tile is requested
+        if (cache.find(tileRow + i) == cache.end()) {
+            posix_fadvise(fd, (off_t)(tileRow + i) * tileStride + offset, tileSize * sizeof(float), POSIX_FADV_WILLNEED);
+        }
+    }
+}
+
+long long TiledMatrix::getTileFaults() { //getter for tile faults
+    return tileFaults;
+}
+
+long long TiledMatrix::getBytesMapped() { //getter for bytes mapped
+    return bytesMapped;
+}
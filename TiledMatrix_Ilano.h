@@ -0,0 +1,49 @@
+/*
+Author: Gabriel Ilano
+Date: 4/19/24
+Description: Declarations for the Tiled Matrix Class, an out of core matrix stored as fixed size tiles in a memory mapped file
+*/
+
+#ifndef TILEDMATRIX_ILANO_H
+#define TILEDMATRIX_ILANO_H
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <stdexcept>
+using namespace std;
+
+struct tile {
+    float* data; //mapped tile memory
+    list<long long>::iterator position; //position of tile within lru list
+};
+
+class TiledMatrix {
+private: //variable declarations
+    int fd; //file descriptor of backing file, the path itself is unlinked as soon as it is created
+    int size; //number of rows and columns
+    int tileSize; //number of rows and columns in each tile
+    int tilesPerSide; //number of tiles along each side of the matrix
+    int cacheTiles; //max number of tiles mapped at once
+    long long tileBytes; //bytes of data in each tile
+    long long tileStride; //bytes between tiles in the file (page aligned)
+    long long tileFaults;
+    long long bytesMapped;
+    long long lastId; //most recently used tile for fast repeated lookups
+    float* lastData;
+    list<long long> lru; //front is most recently used
+    unordered_map<long long, tile> cache;
+
+    float* getTile(long long id); //maps tile into cache if not already present
+    void evictTile(); //unmaps least recently used tile
+
+public: //method declarations
+    TiledMatrix(int size, string filePath, int tileSize, int cacheTiles);
+    ~TiledMatrix();
+    float get(int row, int col);
+    void set(int row, int col, float value);
+    void readRow(int row, float* buffer);
+    void prefetchRow(int row);
+    long long getTileFaults();
+    long long getBytesMapped();
+};
+#endif
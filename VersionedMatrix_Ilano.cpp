@@ -0,0 +1,179 @@
+/*
+Author: Gabriel Ilano
+Date: 4/19/24
+Description: Definitions for the Versioned Matrix Class with copy on write row blocks and epoch based reclamation
+*/
+
+#include "VersionedMatrix_Ilano.h"
+#include <cstring>
+#include <functional>
+#include <thread>
+using namespace std;
+
+VersionedMatrix::VersionedMatrix(int size, bool directed, int blockRows, int readerSlots) { //constructor
+    if (size <= 0 || blockRows <= 0 || readerSlots <= 0) { //throws exception if dimensions are invalid
+        throw invalid_argument("Invalid versioned matrix dimensions");
+    }
+
+    this->size = size;
+    this->directed = directed;
+    this->blockRows = blockRows;
+    this->readerSlots = readerSlots;
+    readers.reset(new atomic<unsigned long long>[readerSlots]);
+
+    matrixVersion* first = new matrixVersion(); //first version starts with no edges
+    int blockCount = (size + blockRows - 1) / blockRows;
+    for (int i = 0; i < blockCount; i++) {
+        first->blocks.push_back(shared_ptr<float[]>(new float[(long long)blockRows * size]()));
+    }
+    first->edges = 0;
+
+    current.store(first);
+    epoch.store(1); //epoch 0 marks a free reader slot
+    for (int i = 0; i < readerSlots; i++) {
+        readers[i].store(0);
+    }
+    batching = false;
+}
+
+VersionedMatrix::~VersionedMatrix() { //destructor, assumes no readers are still pinned
+    for (int i = 0; i < static_cast<int>(retired.size()); i++) {
+        delete retired[i].first;
+    }
+    delete current.load();
+}
+
+snapshot VersionedMatrix::pin() { //registers reader and returns latest version
+    int start = hash<thread::id>()(this_thread::get_id()) % readerSlots; //spread threads across slots
+
+    while (true) { //waits only if more readers pin at once than there are slots
+        for (int i = 0; i < readerSlots; i++) {
+            int slot = (start + i) % readerSlots;
+            unsigned long long expected = 0;
+            if (readers[slot].compare_exchange_strong(expected, epoch.load())) { //slot epoch is published before version is read
+                return {current.load(), slot};
+            }
+        }
+        this_thread::yield();
+    }
+}
+
+void VersionedMatrix::unpin(snapshot pinned) { //frees reader slot so old versions can be reclaimed
+    readers[pinned.slot].store(0);
+}
+
+const float* VersionedMatrix::getRow(snapshot pinned, int row) { //returns row within pinned version
+    return pinned.version->blocks[row / blockRows].get() + (long long)(row % blockRows) * size;
+}
+
+float VersionedMatrix::get(int row, int col) { //returns value at given row and column within latest version
+    snapshot pinned = pin();
+    float value = getRow(pinned, row)[col];
+    unpin(pinned);
+    return value;
+}
+
+int VersionedMatrix::getEdges() { //returns edge count of latest version
+    snapshot pinned = pin();
+    int edges = pinned.version->edges;
+    unpin(pinned);
+    return edges;
+}
+
+void VersionedMatrix::addEdge(int start, int end, float weight) { //queues or applies new edge
+    update({ADD_EDGE, start, end, weight});
+}
+
+void VersionedMatrix::removeEdge(int start, int end) { //queues or applies edge removal
+    update({REMOVE_EDGE, start, end, 0.0});
+}
+
+void VersionedMatrix::setEdgeWeight(int start, int end, float weight) { //queues or applies weight change
+    update({SET_WEIGHT, start, end, weight});
+}
+
+void VersionedMatrix::update(edgeUpdate change) { //publishes change immediately unless a batch is open
+    lock_guard<mutex> lock(writerLock);
+    if (batching) {
+        pending.push_back(change);
+    } else {
+        vector<edgeUpdate> updates(1, change);
+        publish(updates);
+    }
+}
+
+void VersionedMatrix::beginBatch() { //following updates are held until commitBatch
+    lock_guard<mutex> lock(writerLock);
+    batching = true;
+}
+
+void VersionedMatrix::commitBatch() { //publishes all held updates as a single version
+    lock_guard<mutex> lock(writerLock);
+    batching = false;
+    if (!pending.empty()) {
+        publish(pending);
+        pending.clear();
+    }
+}
+
+float* VersionedMatrix::writableRow(matrixVersion* version, vector<bool>& copied, int row) { //returns row the new version owns
+    int block = row / blockRows;
+
+    if (!copied[block]) { //first write to block copies it so older versions are untouched
+        long long count = (long long)blockRows * size;
+        shared_ptr<float[]> copy(new float[count]);
+        memcpy(copy.get(), version->blocks[block].get(), count * sizeof(float));
+        version->blocks[block] = copy;
+        copied[block] = true;
+    }
+    return version->blocks[block].get() + (long long)(row % blockRows) * size;
+}
+
+void VersionedMatrix::publish(vector<edgeUpdate>& updates) { //applies updates to a new version and swaps it in
+    matrixVersion* old = current.load();
+    matrixVersion* next = new matrixVersion(*old); //shares every block with old version
+    vector<bool> copied(next->blocks.size(), false);
+
+    for (int i = 0; i < static_cast<int>(updates.size()); i++) { //same edge rules as the in memory matrix
+        edgeUpdate change = updates[i];
+        float* row = writableRow(next, copied, change.start);
+
+        if (change.type == ADD_EDGE && row[change.end] == 0.0) { //increments edge count if edge is new
+            next->edges++;
+        } else if (change.type == REMOVE_EDGE) { //decrement count of edges
+            next->edges--;
+        }
+
+        row[change.end] = change.weight;
+
+        if (!directed) { //mirroring edge for undirected graphs
+            writableRow(next, copied, change.end)[change.start] = change.weight;
+        }
+    }
+
+    current.store(next); //readers pinning from here on see the new version
+    retired.push_back({old, epoch.fetch_add(1)});
+    reclaim();
+}
+
+void VersionedMatrix::reclaim() { //deletes versions retired before the oldest pinned epoch
+    unsigned long long oldest = ~0ULL; //no readers means everything retired can go
+
+    for (int i = 0; i < readerSlots; i++) {
+        unsigned long long pinned = readers[i].load();
+        if (pinned != 0 && pinned < oldest) {
+            oldest = pinned;
+        }
+    }
+
+    int kept = 0;
+    for (int i = 0; i < static_cast<int>(retired.size()); i++) {
+        if (retired[i].second < oldest) { //every pinned reader started after this version was replaced
+            delete retired[i].first;
+        } else {
+            retired[kept] = retired[i];
+            kept++;
+        }
+    }
+    retired.resize(kept);
+}
@@ -0,0 +1,68 @@
+/*
+Author: Gabriel Ilano
+Date: 4/19/24
+Description: Declarations for the Versioned Matrix Class, a copy on write matrix where readers pin immutable snapshots without locking
+*/
+
+#ifndef VERSIONEDMATRIX_ILANO_H
+#define VERSIONEDMATRIX_ILANO_H
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <stdexcept>
+using namespace std;
+
+struct matrixVersion {
+    vector<shared_ptr<float[]>> blocks; //row blocks, shared between versions until written
+    int edges;
+};
+
+struct snapshot {
+    const matrixVersion* version; //nullptr if graph is not versioned
+    int slot; //reader slot holding the pinned epoch
+};
+
+enum updateType { ADD_EDGE, REMOVE_EDGE, SET_WEIGHT };
+
+struct edgeUpdate {
+    updateType type;
+    int start;
+    int end;
+    float weight;
+};
+
+class VersionedMatrix {
+private: //variable declarations
+    int size; //number of rows and columns
+    int blockRows; //number of rows copied together on write
+    bool directed;
+    atomic<matrixVersion*> current; //latest published version
+    atomic<unsigned long long> epoch; //advanced each time a version is retired
+    int readerSlots; //max number of readers pinned at once, sized by the caller from its thread count
+    unique_ptr<atomic<unsigned long long>[]> readers; //epoch pinned by each reader, 0 if slot is free
+    mutex writerLock; //serializes writers only, readers never take it
+    bool batching;
+    vector<edgeUpdate> pending; //updates waiting for commitBatch
+    vector<pair<matrixVersion*, unsigned long long>> retired; //old versions and the epoch they were retired at
+
+    void publish(vector<edgeUpdate>& updates); //builds and publishes new version, writer lock must be held
+    float* writableRow(matrixVersion* version, vector<bool>& copied, int row); //copies row block on first write
+    void reclaim(); //deletes retired versions no reader can still see
+    void update(edgeUpdate change);
+
+public: //method declarations
+    VersionedMatrix(int size, bool directed, int blockRows, int readerSlots);
+    ~VersionedMatrix();
+    snapshot pin();
+    void unpin(snapshot pinned);
+    const float* getRow(snapshot pinned, int row);
+    float get(int row, int col);
+    int getEdges();
+    void addEdge(int start, int end, float weight);
+    void removeEdge(int start, int end);
+    void setEdgeWeight(int start, int end, float weight);
+    void beginBatch();
+    void commitBatch();
+};
+#endif